@@ -0,0 +1,8 @@
+/*
+ CRC-32 as used in the gzip footer (RFC 1952, Section 8). Shared by ryunzip and ryzip.
+ */
+
+#include <stddef.h>
+
+unsigned long crc32_update(unsigned long crc, const unsigned char *buf, size_t len);
+unsigned long crc32_combine(unsigned long crc1, unsigned long crc2, long len2);
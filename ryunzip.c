@@ -13,6 +13,7 @@
 #include <utime.h>
 
 #include "ryunzip.h"
+#include "crc32.h"
 
 void print_huffman_tree(struct huffman_node *root, unsigned int cur, int len) {
     int i;
@@ -58,13 +59,13 @@ int read_bits(struct deflate_stream *stream, int n, int huffman) {
     return ret;
 }
 
-void set_metadata(struct FullFile *file) {
+void set_metadata(struct FullFile *file, char *filename) {
     struct stat st;
     struct utimbuf utimes;
     time_t mtime_s;
 
     // stat the output file
-    if(stat(file->filename, &st) < 0) {
+    if(stat(filename, &st) < 0) {
         perror("set_metadata: stat failed");
         exit(1);
     }
@@ -72,18 +73,51 @@ void set_metadata(struct FullFile *file) {
     // calculate the mod_time from the header
     mtime_s = *(time_t*)(file->header.mtime);
     mtime_s &= (0xffffffff); // clear out top 4 bits
+    if(mtime_s == 0) return; // no time stamp available (e.g. BGZF)
 
     // set up utimes struct
     utimes.actime = st.st_atime;
     utimes.modtime = mtime_s;
 
     // set new modification time
-    if(utime(file->filename, &utimes) < 0) {
+    if(utime(filename, &utimes) < 0) {
         perror("set_metadata: utime failed");
         exit(1);
     }
 }
 
+// The output always goes in the current directory, named by the header or by the zipped file
+char* output_filename(char *zipfile, struct FullFile *file) {
+    char *name, *base;
+    size_t len;
+
+    if(file->header.flg & FNAME) {
+        base = file->filename;
+        len = strlen(base);
+    } else { // no stored name: strip the .gz suffix from the zipped file's name (as gzip does)
+        base = strrchr(zipfile, '/');
+        base = base?(base + 1):zipfile;
+        len = strlen(base);
+        if(len < 3 || strcmp(base + len - 3, ".gz") != 0) {
+            fprintf(stderr, "no original file name stored and %s does not end in .gz\n", zipfile);
+            exit(1);
+        }
+        len -= 3;
+        if(len == 0) {
+            fprintf(stderr, "no original file name stored and %s has no name before .gz\n", zipfile);
+            exit(1);
+        }
+    }
+
+    if((name = malloc(len + 1)) == NULL) {
+        perror("malloc failed in output_filename");
+        exit(1);
+    }
+    memcpy(name, base, len);
+    name[len] = '\0';
+    return name;
+}
+
 void read_string(struct deflate_stream *stream, char *buf, int MAX_SIZE) {
     int i = 0;
     while(i < MAX_SIZE - 1) {
@@ -133,35 +167,29 @@ void read_header(struct deflate_stream *stream, struct FullFile *file) {
 }
 
 void read_footer(struct deflate_stream *stream, struct FullFile *file) {
-    struct stat st;
     int real_size;
-    long int tmp;
-    char eof;
+    unsigned long checksum;
 
     // read in footer
-    fread(&file->footer, 1, sizeof(file->footer), stream->fp);
-    fread(&eof, 1, 1, stream->fp);
-    if(!feof(stream->fp)) {
-        fprintf(stderr, "Content after footer.\n");
+    if(fread(&file->footer, 1, sizeof(file->footer), stream->fp) < sizeof(file->footer)) {
+        fprintf(stderr, "Missing footer.\n");
         exit(1);
     }
 
-    // stat the output file
-    if(stat(file->filename, &st) < 0) {
-        perror("read_footer: stat failed");
-        exit(1);
-    }
-
-    // Check output filesize against footer filesize data
-    tmp = (long int)st.st_size;
-    tmp %= ((long int)1<<32);
-    real_size = (int)tmp;
+    // Check member output size against footer filesize data
+    real_size = (int)(stream->size & 0xffffffff);
     if(real_size != file->footer.filesize) {
         fprintf(stderr, "File size mod 2^32 (%d) does not match footer.filesize (%d)\n", real_size, file->footer.filesize);
         exit(1);
     }
 
-    // TODO: Check crc32 checksum to validate output data
+    // Check crc32 checksum to validate output data
+    checksum = (unsigned long)file->footer.checksum[0] | ((unsigned long)file->footer.checksum[1] << 8) |
+               ((unsigned long)file->footer.checksum[2] << 16) | ((unsigned long)file->footer.checksum[3] << 24);
+    if(checksum != stream->crc) {
+        fprintf(stderr, "CRC32 of output (%08lx) does not match footer checksum (%08lx)\n", stream->crc, checksum);
+        exit(1);
+    }
 }
 
 void print_header(struct FullFile *file) {
@@ -177,7 +205,7 @@ void print_header(struct FullFile *file) {
 
     // extra data
     if(file->header.flg & FEXTRA) {
-        printf("Extra Text: %s\n", file->fextra);
+        printf("Extra Field: %d bytes\n", file->fextrasize);
     }
     // file name
     if(file->header.flg & FNAME) {
@@ -227,6 +255,19 @@ struct huffman_node* traverse_tree(struct huffman_node *root, unsigned int code,
         }
         root = root->children[bit];
     }
+    return root;
+}
+
+void free_tree(struct huffman_node *root) {
+    int i;
+    for(i = 0; i < 2; ++i) {
+        if(root->children[i] != NULL) {
+            free_tree(root->children[i]);
+            free(root->children[i]);
+            root->children[i] = NULL;
+        }
+    }
+    root->val = -1;
 }
 
 void build_tree(struct huffman_node* root, struct huffman_length lengths[], int lengths_size) {
@@ -266,19 +307,29 @@ void build_tree(struct huffman_node* root, struct huffman_length lengths[], int
     // Build the Huffman lookup tree
     root->val = -1;
     for(i = 0; i < lengths[lengths_size-1].end+1; ++i) {
+        if(tree[i].len == 0) continue; // unused symbol
         curnode = traverse_tree(root, tree[i].code, tree[i].len, 1);
         curnode->val = i;
     }
+    free(tree);
+}
+
+void write_byte(struct deflate_stream *stream, unsigned char c, FILE *out) {
+    stream->window[stream->wpos] = c;
+    stream->wpos = (stream->wpos + 1)%MAX_BACK_DIST;
+    stream->crc = crc32_update(stream->crc, &c, 1);
+    stream->size++;
+    if(fwrite(&c, 1, 1, out) < 1) {
+        perror("Error writing output file");
+        exit(1);
+    }
 }
 
 void decode_block(struct huffman_node *literal_root, struct huffman_node *dist_root, struct deflate_stream *stream, FILE *out, int verbose) {
-    static char buf[MAX_BACK_DIST]; // buffer for backwards distances; remains across blocks
-    
-    int extra, length, dist, bit, pos, backpos, val;
+    int extra, length, dist, bit, backpos, val;
     struct huffman_node *node;
     
     if(verbose) printf("decode_block started\n");
-    pos = 0;
 
     while(1) {
         node = literal_root;
@@ -297,9 +348,7 @@ void decode_block(struct huffman_node *literal_root, struct huffman_node *dist_r
             break;
         } else if(node->val < LITERAL_EXT_BASE) {
             if(verbose) printf(": %c\n", (char)node->val);
-            buf[pos] = (char)node->val;
-            fwrite(buf + pos, 1, 1, out);
-            pos = (pos + 1)%MAX_BACK_DIST;
+            write_byte(stream, (unsigned char)node->val, out);
             continue;
         } else {
             extra = read_bits(stream, LITERAL_EXTRA_BITS(node->val), 0);
@@ -338,21 +387,14 @@ void decode_block(struct huffman_node *literal_root, struct huffman_node *dist_r
             dist = extra_dist_start[node->val] + extra;
         }
 
-        // copy dist bits from backpos to pos
-        backpos = pos - dist;
+        // copy dist bits from backpos to the window position
+        backpos = stream->wpos - dist;
         if(backpos < 0) backpos += MAX_BACK_DIST;
         while(length-->0) {
-            buf[pos] = buf[backpos];
-            fwrite(buf + pos, 1, 1, out);
-            pos = (pos + 1)%MAX_BACK_DIST;
+            write_byte(stream, stream->window[backpos], out);
             backpos = (backpos + 1)%MAX_BACK_DIST;
         }
     }
-
-    if(fclose(out) != 0) {
-        perror("Error occurred when closing output file.");
-        exit(1);
-    }
 }
 
 void decode_code_lengths(struct deflate_stream *stream, struct huffman_node *code_length_root, int *all_lens, int num, int verbose) {
@@ -395,7 +437,7 @@ void read_huffman_codes(struct deflate_stream *stream, struct huffman_node *lite
     struct huffman_node code_length_root, *node;
 
     memset(&code_lengths, 0, sizeof(code_lengths));
-    memset(&temp_lengths, 0, sizeof(code_lengths));
+    memset(&temp_lengths, 0, sizeof(temp_lengths));
     memset(&code_length_root, 0, sizeof(code_length_root));
 
     for(i=0; i<19; i++) code_lengths[i].end = i;
@@ -439,38 +481,40 @@ void read_huffman_codes(struct deflate_stream *stream, struct huffman_node *lite
         }
     }
     build_tree(dist_root, temp_lengths, j+1);
+    free_tree(&code_length_root);
 }
 
-void inflate(struct deflate_stream *stream, char *orig_filename, int verbose) {
-    int bfinal, btype;
+void inflate(struct deflate_stream *stream, FILE *out, int verbose) {
+    int bfinal, btype, i;
     int len, nlen; // case 0
-    char buf[NONCOMPRESSIBLE_BLOCK_SIZE];
+    unsigned char buf[NONCOMPRESSIBLE_BLOCK_SIZE];
     struct huffman_node literal_root, dist_root; // cases 1, 2
-    char filename[MAX_FILE_NAME];
-    FILE *out;
 
-    snprintf(filename, MAX_FILE_NAME, "%s", orig_filename);
-    if((out = fopen(filename, "wb")) == NULL) {
-        perror("Error occurred while opening output file.");
-        exit(1);
-    }
     memset(&literal_root, 0, sizeof(literal_root));
     memset(&dist_root, 0, sizeof(dist_root));
     
     do {
+        // trees from the previous block must not leak into this one
+        free_tree(&literal_root);
+        free_tree(&dist_root);
+
         bfinal = read_bits(stream, 1, 0);
         btype = read_bits(stream, 2, 0);
         if(verbose) printf("\nbfinal: %d, btype: %d\n", bfinal, btype);
         if(btype == 0) { // uncompressed
-            while(stream->pos != 0) read_bits(stream, 1, 0); // ignore remainder of block
-            len = read_bits(stream, 2, 0);
-            nlen = read_bits(stream, 2, 0);
-            if((len & nlen) != 0) { // sanity check
+            while(stream->pos != 0) read_bits(stream, 1, 0); // ignore remainder of byte
+            len = read_bits(stream, 16, 0);
+            nlen = read_bits(stream, 16, 0);
+            if((len ^ nlen) != 0xffff) { // sanity check
                 fprintf(stderr, "len, nlen are not complements\n");
                 exit(1);
             }
-            fread(buf, 1, len, stream->fp);
-            fwrite(buf, 1, len, out);        
+            if(verbose) printf("stored len: %d\n", len);
+            if(fread(buf, 1, len, stream->fp) < (size_t)len) {
+                fprintf(stderr, "Stored block is truncated.\n");
+                exit(1);
+            }
+            for(i = 0; i < len; ++i) write_byte(stream, buf[i], out);
         } else if(btype == 1) { // compressed with fixed Huffman
             build_tree(&literal_root, fixed_huffman, 4);
             // struct huffman_node *temp = traverse_tree(&root, 0b10011000, 8, 0);
@@ -485,16 +529,19 @@ void inflate(struct deflate_stream *stream, char *orig_filename, int verbose) {
             exit(1);
         }
     } while(bfinal != 1);
+
+    free_tree(&literal_root);
+    free_tree(&dist_root);
 }
 
 int main(int argc, char *argv[]) {
     struct deflate_stream stream;
-    struct FullFile file;
-    char *zipfile;
-    int verbose = 0;
+    struct FullFile file, first;
+    char *zipfile, *outname;
+    FILE *out = NULL;
+    int c, verbose = 0;
 
     memset(&stream, 0, sizeof(stream));
-    memset(&file, 0, sizeof(file));
     
     // Check Arguments
     if(argc < 2 || argc > 3) { // check number of arguments
@@ -517,16 +564,41 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
-    read_header(&stream, &file);
-    if(verbose) print_header(&file);
+    // a gzip file is a series of members whose outputs are concatenated (RFC 1952, Section 2.2)
+    do {
+        memset(&file, 0, sizeof(file));
+        read_header(&stream, &file);
+        if(verbose) print_header(&file);
+
+        if(out == NULL) { // the first member names the output file
+            first = file;
+            outname = output_filename(zipfile, &first);
+            if((out = fopen(outname, "wb")) == NULL) {
+                perror("Error occurred while opening output file.");
+                return 1;
+            }
+        }
 
-    inflate(&stream, file.filename, verbose);
+        stream.pos = 0;
+        stream.crc = 0;
+        stream.size = 0;
+        inflate(&stream, out, verbose);
     
-    read_footer(&stream, &file);
-    if(verbose) print_footer(&file);
+        read_footer(&stream, &file);
+        if(verbose) print_footer(&file);
+        free(file.fextra);
+
+        if((c = fgetc(stream.fp)) != EOF) ungetc(c, stream.fp);
+    } while(c != EOF);
+
+    if(fclose(out) != 0) {
+        perror("Error occurred when closing output file.");
+        return 1;
+    }
 
     // set correct metadata
-    set_metadata(&file);
+    set_metadata(&first, outname);
+    free(outname);
 
     if(fclose(stream.fp) != 0) {
         perror("Error occurred while closing file.");
@@ -5,6 +5,7 @@
 #define MAX_HUFFMAN_LENGTH 15 // because the code length spec only gives literals from 0-15
 #define MAX_FILE_NAME 100 // arbitrarily set
 #define MAX_COMMENT_NAME 200 // arbitrarily set
+#define MAX_STRING_LEN(MAX_SIZE) ((MAX_SIZE) - 2) // longest string read_string accepts (it reads at most MAX_SIZE - 1 bytes, NUL included)
 #define MAX_BACK_DIST (1<<15)
 #define NONCOMPRESSIBLE_BLOCK_SIZE (1<<16) // max size for uncompressed block
 
@@ -20,6 +21,10 @@ struct deflate_stream {
     FILE *fp;
     unsigned char buf;
     unsigned char pos;
+    unsigned char window[MAX_BACK_DIST]; // buffer for backwards distances; remains across blocks
+    int wpos;
+    unsigned long crc; // crc32 of the current member's output so far
+    unsigned long size; // bytes output for the current member so far
 };
 
 // Gzip File Format
@@ -122,14 +127,18 @@ void print_header(struct FullFile *file);
 void read_footer(struct deflate_stream *stream, struct FullFile *file);
 void print_footer(struct FullFile *file);
 
-void set_metadata(struct FullFile *file);
+void set_metadata(struct FullFile *file, char *filename);
+char* output_filename(char *zipfile, struct FullFile *file);
 
 void print_huffman_tree(struct huffman_node *root, unsigned int cur, int len);
 struct huffman_node* traverse_tree(struct huffman_node *root, unsigned int code, int len, int create);
 void build_tree(struct huffman_node *root, struct huffman_length lengths[], int lengths_size);
+void free_tree(struct huffman_node *root);
+
+void write_byte(struct deflate_stream *stream, unsigned char c, FILE *out);
 
 void decode_block(struct huffman_node *literal_root, struct huffman_node *dist_root, struct deflate_stream *stream, FILE *out, int verbose);
 void decode_code_lengths(struct deflate_stream *stream, struct huffman_node *code_length_root, int *all_lens, int num, int verbose);
 void read_huffman_codes(struct deflate_stream *stream, struct huffman_node *literal_root, struct huffman_node *dist_root, int verbose);
 
-void inflate(struct deflate_stream *stream, char *orig_filename, int verbose);
\ No newline at end of file
+void inflate(struct deflate_stream *stream, FILE *out, int verbose);
\ No newline at end of file
@@ -0,0 +1,671 @@
+/*
+  A parallel DEFLATE compressor that writes gzip files (RFC 1951, 1952 for format) readable by ryunzip.
+  The input is split into chunks which are compressed on a pool of threads; each chunk's matcher is
+  primed with the 32 KiB of input before it, so the chunks join into a single DEFLATE stream.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
+
+#include "ryunzip.h"
+#include "ryzip.h"
+#include "crc32.h"
+
+// Lookup tables derived from the shared format tables in ryunzip.h
+unsigned char length_code[MAX_MATCH+1]; // match length -> index into extra_alpha_start
+unsigned char dist_code[MAX_BACK_DIST+1]; // match distance -> index into extra_dist_start
+struct huffman_code fixed_literal_codes[FIXED_LITERAL_CODES];
+struct huffman_code fixed_dist_codes[FIXED_DIST_CODES];
+
+void init_code_tables(void) {
+    unsigned char lens[FIXED_LITERAL_CODES];
+    int i, j, len, dist;
+
+    for(i = 0, len = MIN_MATCH; len <= MAX_MATCH; ++len) {
+        while(i < LITERAL_MAX - LITERAL_EXT_BASE && extra_alpha_start[i+1] <= len) ++i;
+        length_code[len] = i;
+    }
+    for(i = 0, dist = 1; dist <= MAX_BACK_DIST; ++dist) {
+        while(i < DIST_MAX && extra_dist_start[i+1] <= dist) ++i;
+        dist_code[dist] = i;
+    }
+
+    // Fixed Huffman codes (RFC 1951, Section 3.2.6)
+    for(i = 0, j = 0; i < FIXED_LITERAL_CODES; ++i) {
+        if(i > fixed_huffman[j].end) ++j;
+        lens[i] = fixed_huffman[j].len;
+    }
+    huffman_codes(lens, FIXED_LITERAL_CODES, fixed_literal_codes);
+    memset(lens, FIXED_DIST_BITS, FIXED_DIST_CODES);
+    huffman_codes(lens, FIXED_DIST_CODES, fixed_dist_codes);
+}
+
+void put_byte(struct bit_writer *w, unsigned char c) {
+    if(w->len == w->cap) {
+        w->cap = w->cap ? 2*w->cap : (1<<16);
+        if((w->data = realloc(w->data, w->cap)) == NULL) {
+            perror("realloc failed in put_byte");
+            exit(1);
+        }
+    }
+    w->data[w->len++] = c;
+}
+
+void put_bits(struct bit_writer *w, unsigned int value, int n) {
+    w->bitbuf |= (unsigned long long)value << w->bitcount;
+    w->bitcount += n;
+    while(w->bitcount >= 8) {
+        put_byte(w, w->bitbuf & 0xff);
+        w->bitbuf >>= 8;
+        w->bitcount -= 8;
+    }
+}
+
+void align_bits(struct bit_writer *w) {
+    if(w->bitcount > 0) put_bits(w, 0, 8 - w->bitcount);
+}
+
+// Run-length encodes code lengths with the repeat codes 16, 17, 18 (RFC 1951, Section 3.2.7)
+int rle_code_lengths(const unsigned char *lens, int n, unsigned char *syms, unsigned char *extra) {
+    int i = 0, run, r, count = 0;
+
+    while(i < n) {
+        for(run = 1; i + run < n && lens[i + run] == lens[i]; ++run);
+        if(lens[i] == 0) {
+            while(run >= 11) { // 18: repeat zero 11-138 times
+                r = (run < 138)?run:138;
+                syms[count] = 18;
+                extra[count++] = r - 11;
+                run -= r;
+                i += r;
+            }
+            if(run >= 3) { // 17: repeat zero 3-10 times
+                syms[count] = 17;
+                extra[count++] = run - 3;
+                i += run;
+                run = 0;
+            }
+        } else {
+            syms[count] = lens[i]; // 16 repeats the previous length, so send it once first
+            extra[count++] = 0;
+            ++i;
+            --run;
+            while(run >= 3) { // 16: repeat previous 3-6 times
+                r = (run < 6)?run:6;
+                syms[count] = 16;
+                extra[count++] = r - 3;
+                run -= r;
+                i += r;
+            }
+        }
+        while(run-- > 0) {
+            syms[count] = lens[i++];
+            extra[count++] = 0;
+        }
+    }
+    return count;
+}
+
+// Computes Huffman code lengths of at most limit bits for the symbols 0..n-1
+void huffman_lengths(const unsigned int *freq, int n, int limit, unsigned char *lens) {
+    int syms[LITERAL_CODES], parent[2*LITERAL_CODES], depth[2*LITERAL_CODES];
+    unsigned long weight[2*LITERAL_CODES], total;
+    int bl_count[MAX_HUFFMAN_LENGTH+1];
+    int m = 0, i, j, sym, leaf, next, node, a, len;
+
+    memset(lens, 0, n);
+    for(i = 0; i < n; ++i) {
+        if(freq[i]) syms[m++] = i;
+    }
+    for(i = 0; m < 2; ++i) { // a complete code needs at least two symbols
+        if(!freq[i]) syms[m++] = i;
+    }
+
+    // sort by ascending frequency (n is small, so insertion sort)
+    for(i = 1; i < m; ++i) {
+        sym = syms[i];
+        for(j = i; j > 0 && freq[syms[j-1]] > freq[sym]; --j) syms[j] = syms[j-1];
+        syms[j] = sym;
+    }
+    for(i = 0; i < m; ++i) weight[i] = freq[syms[i]];
+
+    // Build the tree with two queues: the leaves, and the internal nodes (created in ascending weight order)
+    leaf = 0;
+    next = m;
+    for(node = m; node < 2*m - 1; ++node) {
+        weight[node] = 0;
+        for(j = 0; j < 2; ++j) {
+            if(leaf < m && (next >= node || weight[leaf] <= weight[next])) a = leaf++;
+            else a = next++;
+            parent[a] = node;
+            weight[node] += weight[a];
+        }
+    }
+    depth[2*m - 2] = 0;
+    for(i = 2*m - 3; i >= 0; --i) depth[i] = depth[parent[i]] + 1;
+
+    // Limit lengths: clamp, then lengthen codes until the Kraft sum fits again
+    memset(bl_count, 0, sizeof(bl_count));
+    for(i = 0; i < m; ++i) bl_count[(depth[i] > limit)?limit:depth[i]]++;
+    total = 0;
+    for(len = 1; len <= limit; ++len) total += (unsigned long)bl_count[len] << (limit - len);
+    while(total > (1UL << limit)) {
+        bl_count[limit]--;
+        for(len = limit - 1; len > 0; --len) {
+            if(bl_count[len]) {
+                bl_count[len]--;
+                bl_count[len+1] += 2;
+                break;
+            }
+        }
+        total--;
+    }
+
+    // the least frequent symbols get the longest codes
+    i = 0;
+    for(len = limit; len > 0; --len) {
+        for(j = bl_count[len]; j > 0; --j) lens[syms[i++]] = len;
+    }
+}
+
+// Assigns canonical codes to the given lengths (from RFC 1951, Section 3.2.2)
+void huffman_codes(const unsigned char *lens, int n, struct huffman_code *codes) {
+    int i, bit, bl_count[MAX_HUFFMAN_LENGTH+1];
+    unsigned int next_code[MAX_HUFFMAN_LENGTH+1], code, rev;
+
+    memset(bl_count, 0, sizeof(bl_count));
+    for(i = 0; i < n; ++i) bl_count[lens[i]]++;
+    bl_count[0] = 0;
+
+    code = 0;
+    for(i = 1; i <= MAX_HUFFMAN_LENGTH; ++i) {
+        code = (code + bl_count[i-1]) << 1;
+        next_code[i] = code;
+    }
+
+    for(i = 0; i < n; ++i) {
+        codes[i].len = lens[i];
+        if(lens[i] == 0) continue;
+        code = next_code[lens[i]]++;
+        rev = 0;
+        for(bit = 0; bit < lens[i]; ++bit) { // Huffman codes are packed MSB first
+            rev = (rev << 1) | (code & 1);
+            code >>= 1;
+        }
+        codes[i].code = rev;
+    }
+}
+
+void write_tokens(struct bit_writer *w, struct token *tokens, int ntokens, struct huffman_code *lit_codes, struct huffman_code *dist_codes) {
+    int i, code, sym;
+
+    for(i = 0; i < ntokens; ++i) {
+        if(tokens[i].dist == 0) {
+            put_bits(w, lit_codes[tokens[i].litlen].code, lit_codes[tokens[i].litlen].len);
+            continue;
+        }
+        code = length_code[tokens[i].litlen];
+        sym = LITERAL_EXT_BASE + code;
+        put_bits(w, lit_codes[sym].code, lit_codes[sym].len);
+        put_bits(w, tokens[i].litlen - extra_alpha_start[code], LITERAL_EXTRA_BITS(sym));
+
+        code = dist_code[tokens[i].dist];
+        put_bits(w, dist_codes[code].code, dist_codes[code].len);
+        put_bits(w, tokens[i].dist - extra_dist_start[code], DIST_EXTRA_BITS(code));
+    }
+    put_bits(w, lit_codes[END_OF_BLOCK].code, lit_codes[END_OF_BLOCK].len);
+}
+
+void write_stored(struct bit_writer *w, const unsigned char *raw, long rawlen, int final) {
+    long i, len;
+
+    do {
+        len = (rawlen > STORED_BLOCK_MAX)?STORED_BLOCK_MAX:rawlen;
+        rawlen -= len;
+        put_bits(w, (final && rawlen == 0)?1:0, 1);
+        put_bits(w, 0, 2);
+        align_bits(w);
+        put_bits(w, len, 16);
+        put_bits(w, len ^ 0xffff, 16);
+        for(i = 0; i < len; ++i) put_byte(w, raw[i]);
+        raw += len;
+    } while(rawlen > 0);
+}
+
+// Writes the tokens as whichever block type is smallest: dynamic Huffman, fixed Huffman or stored
+void write_block(struct bit_writer *w, struct token *tokens, int ntokens, const unsigned char *raw, long rawlen, int final, struct options *opts) {
+    unsigned int lit_freq[LITERAL_CODES], dist_freq[DIST_CODES], cl_freq[CODE_LENGTH_CODES];
+    unsigned char lit_lens[LITERAL_CODES], dist_lens[DIST_CODES], cl_lens[CODE_LENGTH_CODES];
+    unsigned char all_lens[LITERAL_CODES + DIST_CODES], rle_syms[LITERAL_CODES + DIST_CODES], rle_extra[LITERAL_CODES + DIST_CODES];
+    struct huffman_code lit_codes[LITERAL_CODES], dist_codes[DIST_CODES], cl_codes[CODE_LENGTH_CODES];
+    unsigned long extra_bits, fixed_bits, dynamic_bits, stored_bits;
+    int i, sym, hlit, hdist, hclen, nrle;
+
+    // Count symbol frequencies
+    memset(lit_freq, 0, sizeof(lit_freq));
+    memset(dist_freq, 0, sizeof(dist_freq));
+    for(i = 0; i < ntokens; ++i) {
+        if(tokens[i].dist == 0) {
+            lit_freq[tokens[i].litlen]++;
+        } else {
+            lit_freq[LITERAL_EXT_BASE + length_code[tokens[i].litlen]]++;
+            dist_freq[dist_code[tokens[i].dist]]++;
+        }
+    }
+    lit_freq[END_OF_BLOCK]++;
+
+    // Cost of each block type in bits (extra bits are the same for both Huffman types)
+    extra_bits = 0;
+    for(sym = LITERAL_EXT_BASE; sym <= LITERAL_MAX; ++sym) extra_bits += (unsigned long)lit_freq[sym] * LITERAL_EXTRA_BITS(sym);
+    for(i = 0; i < DIST_CODES; ++i) extra_bits += (unsigned long)dist_freq[i] * DIST_EXTRA_BITS(i);
+
+    fixed_bits = 3 + extra_bits;
+    for(i = 0; i < LITERAL_CODES; ++i) fixed_bits += (unsigned long)lit_freq[i] * fixed_literal_codes[i].len;
+    for(i = 0; i < DIST_CODES; ++i) fixed_bits += (unsigned long)dist_freq[i] * FIXED_DIST_BITS;
+
+    stored_bits = 8*rawlen + 40*(rawlen/STORED_BLOCK_MAX + 1); // header, padding and LEN/NLEN per block
+
+    dynamic_bits = (unsigned long)-1;
+    if(!opts->fixed_only) {
+        huffman_lengths(lit_freq, LITERAL_CODES, MAX_HUFFMAN_LENGTH, lit_lens);
+        huffman_lengths(dist_freq, DIST_CODES, MAX_HUFFMAN_LENGTH, dist_lens);
+        for(hlit = LITERAL_CODES; hlit > HLIT_OFFSET && lit_lens[hlit-1] == 0; --hlit);
+        for(hdist = DIST_CODES; hdist > HDIST_OFFSET && dist_lens[hdist-1] == 0; --hdist);
+
+        // code lengths are sent as one sequence, compressed with their own Huffman code
+        memcpy(all_lens, lit_lens, hlit);
+        memcpy(all_lens + hlit, dist_lens, hdist);
+        nrle = rle_code_lengths(all_lens, hlit + hdist, rle_syms, rle_extra);
+        memset(cl_freq, 0, sizeof(cl_freq));
+        for(i = 0; i < nrle; ++i) cl_freq[rle_syms[i]]++;
+        huffman_lengths(cl_freq, CODE_LENGTH_CODES, MAX_CODE_LENGTH_BITS, cl_lens);
+        for(hclen = CODE_LENGTH_CODES; hclen > HCLEN_OFFSET && cl_lens[code_length_order[hclen-1]] == 0; --hclen);
+
+        dynamic_bits = 3 + HLIT_LEN + HDIST_LEN + HCLEN_LEN + 3*hclen + extra_bits;
+        for(i = 0; i < nrle; ++i) {
+            dynamic_bits += cl_lens[rle_syms[i]];
+            if(rle_syms[i] >= CODE_LENGTH_EXT_BASE) dynamic_bits += code_length_extra_bits[rle_syms[i] - CODE_LENGTH_EXT_BASE];
+        }
+        for(i = 0; i < LITERAL_CODES; ++i) dynamic_bits += (unsigned long)lit_freq[i] * lit_lens[i];
+        for(i = 0; i < DIST_CODES; ++i) dynamic_bits += (unsigned long)dist_freq[i] * dist_lens[i];
+    }
+
+    if(stored_bits < fixed_bits && stored_bits < dynamic_bits) { // incompressible
+        write_stored(w, raw, rawlen, final);
+    } else if(fixed_bits <= dynamic_bits) { // compressed with fixed Huffman
+        put_bits(w, final, 1);
+        put_bits(w, 1, 2);
+        write_tokens(w, tokens, ntokens, fixed_literal_codes, fixed_dist_codes);
+    } else { // compressed with dynamic Huffman
+        put_bits(w, final, 1);
+        put_bits(w, 2, 2);
+        put_bits(w, hlit - HLIT_OFFSET, HLIT_LEN);
+        put_bits(w, hdist - HDIST_OFFSET, HDIST_LEN);
+        put_bits(w, hclen - HCLEN_OFFSET, HCLEN_LEN);
+        for(i = 0; i < hclen; ++i) put_bits(w, cl_lens[code_length_order[i]], 3);
+
+        huffman_codes(cl_lens, CODE_LENGTH_CODES, cl_codes);
+        for(i = 0; i < nrle; ++i) {
+            put_bits(w, cl_codes[rle_syms[i]].code, cl_codes[rle_syms[i]].len);
+            if(rle_syms[i] >= CODE_LENGTH_EXT_BASE) put_bits(w, rle_extra[i], code_length_extra_bits[rle_syms[i] - CODE_LENGTH_EXT_BASE]);
+        }
+
+        huffman_codes(lit_lens, LITERAL_CODES, lit_codes);
+        huffman_codes(dist_lens, DIST_CODES, dist_codes);
+        write_tokens(w, tokens, ntokens, lit_codes, dist_codes);
+    }
+}
+
+// Adds pos to its hash chain and returns the previous head of the chain
+int insert_hash(struct lz_state *s, long pos) {
+    const unsigned char *p = s->buf + pos;
+    int h = ((p[0] << 10) ^ (p[1] << 5) ^ p[2]) & (HASH_SIZE - 1);
+    s->prev[pos] = s->head[h];
+    s->head[h] = pos;
+    return s->prev[pos];
+}
+
+// Walks the hash chain from cand for a match at pos longer than prev_len; returns its length or 0
+int longest_match(struct lz_state *s, long pos, int cand, int prev_len, struct level_config *cfg, int *dist) {
+    const unsigned char *scan = s->buf + pos, *match;
+    int chain_len = cfg->max_chain, found = 0, len;
+    int best = (prev_len < MIN_MATCH)?(MIN_MATCH - 1):prev_len;
+    int max_len = (s->total - pos < MAX_MATCH)?(int)(s->total - pos):MAX_MATCH;
+    int nice = (cfg->nice_length < max_len)?cfg->nice_length:max_len;
+    long limit = (pos > MAX_BACK_DIST)?(pos - MAX_BACK_DIST):0;
+
+    if(best >= max_len) return 0;
+    if(prev_len >= cfg->good_length) chain_len >>= 2;
+
+    while(cand != NIL && cand >= limit && chain_len-- > 0) {
+        match = s->buf + cand;
+        if(match[best] == scan[best] && match[0] == scan[0] && match[1] == scan[1]) {
+            len = 2;
+            while(len < max_len && match[len] == scan[len]) ++len;
+            if(len > best) {
+                best = len;
+                *dist = pos - cand;
+                found = 1;
+                if(len >= nice) break;
+            }
+        }
+        cand = s->prev[cand];
+    }
+    return found?best:0;
+}
+
+// Adds a token covering the input up to end, writing out the block once it is full
+void emit_token(struct lz_state *s, struct chunk_job *job, struct options *opts, int litlen, int dist, long end) {
+    s->tokens[s->ntokens].litlen = litlen;
+    s->tokens[s->ntokens].dist = dist;
+    if(++s->ntokens == BLOCK_TOKENS) {
+        write_block(&job->out, s->tokens, s->ntokens, s->buf + s->block_start, end - s->block_start, 0, opts);
+        s->ntokens = 0;
+        s->block_start = end;
+    }
+}
+
+void deflate_chunk(struct chunk_job *job, struct options *opts) {
+    struct level_config *cfg = &level_configs[opts->level];
+    struct lz_state s;
+    long pos, p, end;
+    int chain, cur_len, cur_dist = 0, prev_len = 0, prev_dist = 0, match_available = 0;
+
+    s.buf = job->in - job->dict_len;
+    s.total = job->dict_len + job->len;
+    s.ntokens = 0;
+    s.block_start = job->dict_len;
+    if((s.head = malloc(HASH_SIZE * sizeof(int))) == NULL || (s.prev = malloc((s.total + 1) * sizeof(int))) == NULL ||
+       (s.tokens = malloc(BLOCK_TOKENS * sizeof(struct token))) == NULL) {
+        perror("malloc failed in deflate_chunk");
+        exit(1);
+    }
+    memset(s.head, 0xff, HASH_SIZE * sizeof(int)); // all NIL
+
+    // prime the matcher with the end of the previous chunk
+    for(p = 0; p < job->dict_len && p + MIN_MATCH <= s.total; ++p) insert_hash(&s, p);
+
+    pos = job->dict_len;
+    if(!cfg->lazy) { // greedy: take the first match found
+        while(pos < s.total) {
+            cur_len = 0;
+            if(pos + MIN_MATCH <= s.total) {
+                chain = insert_hash(&s, pos);
+                cur_len = longest_match(&s, pos, chain, 0, cfg, &cur_dist);
+            }
+            if(cur_len >= MIN_MATCH) {
+                end = pos + cur_len;
+                emit_token(&s, job, opts, cur_len, cur_dist, end);
+                if(cur_len <= cfg->max_lazy) { // only index short matches; long ones take too long
+                    for(p = pos + 1; p < end && p + MIN_MATCH <= s.total; ++p) insert_hash(&s, p);
+                }
+                pos = end;
+            } else {
+                emit_token(&s, job, opts, s.buf[pos], 0, pos + 1);
+                ++pos;
+            }
+        }
+    } else { // lazy: only take the match at pos-1 if pos doesn't have a longer one
+        while(pos < s.total) {
+            cur_len = 0;
+            if(pos + MIN_MATCH <= s.total) {
+                chain = insert_hash(&s, pos);
+                if(!match_available || prev_len < cfg->max_lazy) {
+                    cur_len = longest_match(&s, pos, chain, prev_len, cfg, &cur_dist);
+                }
+            }
+            if(match_available && prev_len >= MIN_MATCH && cur_len <= prev_len) {
+                end = pos - 1 + prev_len;
+                emit_token(&s, job, opts, prev_len, prev_dist, end);
+                for(p = pos + 1; p < end && p + MIN_MATCH <= s.total; ++p) insert_hash(&s, p);
+                pos = end;
+                match_available = 0;
+                prev_len = 0;
+            } else {
+                if(match_available) emit_token(&s, job, opts, s.buf[pos-1], 0, pos);
+                prev_len = cur_len;
+                prev_dist = cur_dist;
+                match_available = 1;
+                ++pos;
+            }
+        }
+        if(match_available) emit_token(&s, job, opts, s.buf[pos-1], 0, pos);
+    }
+
+    if(s.ntokens > 0 || job->last) {
+        write_block(&job->out, s.tokens, s.ntokens, s.buf + s.block_start, s.total - s.block_start, job->last, opts);
+    }
+    if(job->last) align_bits(&job->out);
+    else write_stored(&job->out, NULL, 0, 0); // empty stored block byte-aligns the chunk for concatenation
+
+    job->crc = crc32_update(0, job->in, job->len);
+
+    free(s.head);
+    free(s.prev);
+    free(s.tokens);
+}
+
+void *worker(void *arg) {
+    struct thread_pool *pool = arg;
+    int i;
+
+    while(1) {
+        pthread_mutex_lock(&pool->lock);
+        i = pool->next++;
+        pthread_mutex_unlock(&pool->lock);
+        if(i >= pool->njobs) break;
+
+        deflate_chunk(&pool->jobs[i], pool->opts);
+
+        pthread_mutex_lock(&pool->lock);
+        pool->jobs[i].done = 1;
+        pthread_cond_broadcast(&pool->done_cond);
+        pthread_mutex_unlock(&pool->lock);
+    }
+    return NULL;
+}
+
+void write_out(FILE *out, const void *buf, size_t len) {
+    if(fwrite(buf, 1, len, out) < len) {
+        perror("Error writing output file");
+        exit(1);
+    }
+}
+
+void write_header(FILE *out, struct options *opts, char *filename, time_t mtime) {
+    struct Header header;
+    int i;
+
+    memset(&header, 0, sizeof(header));
+    header.id1 = 0x1f;
+    header.id2 = 0x8b;
+    header.cm = 0x08;
+    if(strlen(filename) <= MAX_STRING_LEN(MAX_FILE_NAME)) header.flg = FNAME; // otherwise the name is derived from the .gz name
+    for(i = 0; i < 4; ++i) header.mtime[i] = (mtime >> (8*i)) & 0xff;
+    if(opts->level == 9) header.xfl = 2;
+    else if(opts->level == 1) header.xfl = 4;
+    header.os = 3; // Unix
+
+    write_out(out, &header, sizeof(header));
+    if(header.flg & FNAME) write_out(out, filename, strlen(filename) + 1);
+}
+
+void write_footer(FILE *out, unsigned long crc, unsigned long size) {
+    unsigned char footer[FOOTER_SIZE];
+    int i;
+
+    for(i = 0; i < 4; ++i) {
+        footer[i] = (crc >> (8*i)) & 0xff;
+        footer[4+i] = (size >> (8*i)) & 0xff;
+    }
+    write_out(out, footer, FOOTER_SIZE);
+}
+
+void write_bgzf_member(FILE *out, struct chunk_job *job) {
+    unsigned long bsize = BGZF_HEADER_SIZE + job->out.len + FOOTER_SIZE;
+    unsigned char header[BGZF_HEADER_SIZE] = {
+        0x1f, 0x8b, 0x08, FEXTRA, 0, 0, 0, 0, 0, 0xff, // no mtime, unknown OS
+        BGZF_XLEN, 0, 'B', 'C', 2, 0, 0, 0 // BC subfield: member size - 1
+    };
+
+    if(bsize > BGZF_MAX_MEMBER) {
+        fprintf(stderr, "BGZF member too large: %lu bytes\n", bsize);
+        exit(1);
+    }
+    header[16] = (bsize - 1) & 0xff;
+    header[17] = (bsize - 1) >> 8;
+    write_out(out, header, BGZF_HEADER_SIZE);
+    write_out(out, job->out.data, job->out.len);
+    write_footer(out, job->crc, job->len);
+}
+
+void compress_file(char *filename, struct options *opts) {
+    struct stat st;
+    struct thread_pool pool;
+    struct chunk_job *jobs;
+    pthread_t threads[MAX_THREADS];
+    char *outname, *basename;
+    unsigned char *data;
+    unsigned long crc = 0;
+    long size, offset;
+    int i, nthreads;
+    FILE *in, *out;
+
+    // Read in the whole input; chunks need the previous chunk's tail as a dictionary
+    if(stat(filename, &st) < 0 || (in = fopen(filename, "rb")) == NULL) {
+        perror("Invalid file; can't open.");
+        exit(1);
+    }
+    size = (long)st.st_size;
+    if((data = malloc(size + 1)) == NULL) {
+        perror("malloc failed in compress_file");
+        exit(1);
+    }
+    if(fread(data, 1, size, in) < (size_t)size) {
+        perror("Error reading input file");
+        exit(1);
+    }
+    fclose(in);
+
+    if((outname = malloc(strlen(filename) + 4)) == NULL) {
+        perror("malloc failed in compress_file");
+        exit(1);
+    }
+    sprintf(outname, "%s.gz", filename);
+    if((out = fopen(outname, "wb")) == NULL) {
+        perror("Error occurred while opening output file.");
+        exit(1);
+    }
+
+    // Split the input into chunks
+    memset(&pool, 0, sizeof(pool));
+    pool.njobs = (size > 0)?((size + opts->chunk_size - 1) / opts->chunk_size):1;
+    if((jobs = calloc(pool.njobs, sizeof(struct chunk_job))) == NULL) {
+        perror("calloc failed in compress_file");
+        exit(1);
+    }
+    for(i = 0; i < pool.njobs; ++i) {
+        offset = i * opts->chunk_size;
+        jobs[i].in = data + offset;
+        jobs[i].len = (size - offset < opts->chunk_size)?(size - offset):opts->chunk_size;
+        jobs[i].dict_len = opts->independent?0:((offset < MAX_BACK_DIST)?offset:MAX_BACK_DIST);
+        jobs[i].last = opts->independent || i == pool.njobs - 1;
+    }
+    pool.jobs = jobs;
+    pool.opts = opts;
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_cond_init(&pool.done_cond, NULL);
+
+    nthreads = (opts->threads < pool.njobs)?opts->threads:pool.njobs;
+    for(i = 0; i < nthreads; ++i) {
+        if((errno = pthread_create(&threads[i], NULL, worker, &pool)) != 0) {
+            perror("pthread_create failed");
+            exit(1);
+        }
+    }
+
+    if(!opts->independent) {
+        basename = strrchr(filename, '/');
+        write_header(out, opts, basename?(basename + 1):filename, st.st_mtime);
+    }
+
+    // Write out the chunks in order as they finish
+    for(i = 0; i < pool.njobs; ++i) {
+        pthread_mutex_lock(&pool.lock);
+        while(!jobs[i].done) pthread_cond_wait(&pool.done_cond, &pool.lock);
+        pthread_mutex_unlock(&pool.lock);
+
+        if(opts->verbose) printf("chunk %d: %ld -> %lu bytes\n", i, jobs[i].len, (unsigned long)jobs[i].out.len);
+        if(opts->independent) {
+            write_bgzf_member(out, &jobs[i]);
+        } else {
+            write_out(out, jobs[i].out.data, jobs[i].out.len);
+            crc = crc32_combine(crc, jobs[i].crc, jobs[i].len);
+        }
+        free(jobs[i].out.data);
+    }
+    for(i = 0; i < nthreads; ++i) pthread_join(threads[i], NULL);
+
+    if(opts->independent) write_out(out, bgzf_eof, sizeof(bgzf_eof));
+    else write_footer(out, crc, size);
+    if(opts->verbose) {
+        printf("%s: %ld -> %ld bytes", outname, size, ftell(out));
+        if(!opts->independent) printf(", crc32 %08lx", crc); // each BGZF member carries its own
+        printf("\n");
+    }
+
+    if(fflush(out) != 0 || ferror(out) || fclose(out) != 0) {
+        perror("Error occurred while closing output file.");
+        exit(1);
+    }
+    pthread_mutex_destroy(&pool.lock);
+    pthread_cond_destroy(&pool.done_cond);
+    free(jobs);
+    free(data);
+    free(outname);
+}
+
+void usage(void) {
+    fprintf(stderr, "Usage: ryzip [-v] [-1..-9] [-p threads] [-b chunk KiB] [-i] [--fixed] <file>\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[]) {
+    struct options opts;
+    struct option long_options[] = {
+        {"fixed", no_argument, NULL, 'F'}, // long only: gzip's -f means force
+        {NULL, 0, NULL, 0}
+    };
+    int c;
+
+    memset(&opts, 0, sizeof(opts));
+    opts.level = DEFAULT_LEVEL;
+    opts.threads = sysconf(_SC_NPROCESSORS_ONLN);
+    opts.chunk_size = DEFAULT_CHUNK_SIZE;
+
+    // Check Arguments
+    while((c = getopt_long(argc, argv, "123456789p:b:iv", long_options, NULL)) != -1) {
+        if(c >= '1' && c <= '9') opts.level = c - '0';
+        else if(c == 'p') opts.threads = atoi(optarg);
+        else if(c == 'b') opts.chunk_size = atol(optarg) * 1024;
+        else if(c == 'i') opts.independent = 1;
+        else if(c == 'F') opts.fixed_only = 1;
+        else if(c == 'v') opts.verbose = 1;
+        else usage();
+    }
+    if(optind != argc - 1 || opts.chunk_size <= 0) usage();
+    if(opts.threads < 1) opts.threads = 1;
+    if(opts.threads > MAX_THREADS) opts.threads = MAX_THREADS;
+    if(opts.independent && opts.chunk_size > BGZF_CHUNK_SIZE) opts.chunk_size = BGZF_CHUNK_SIZE;
+
+    init_code_tables();
+    compress_file(argv[optind], &opts);
+    return 0;
+}
@@ -0,0 +1,141 @@
+/*
+ Definitions for the ryzip compressor. The DEFLATE/gzip format tables themselves are shared with
+ the decompressor through ryunzip.h.
+ */
+
+#define MIN_MATCH 3
+#define MAX_MATCH 258
+#define HASH_BITS 15
+#define HASH_SIZE (1<<HASH_BITS)
+#define NIL (-1) // end of a hash chain
+
+#define LITERAL_CODES (LITERAL_MAX+1) // 0-285
+#define DIST_CODES (DIST_MAX+1) // 0-29
+#define CODE_LENGTH_CODES 19
+#define MAX_CODE_LENGTH_BITS 7 // code length codes are sent in 3 bits
+#define STORED_BLOCK_MAX 0xffff // LEN is 16 bits
+#define FIXED_LITERAL_CODES 288 // fixed code also assigns lengths to the unused 286, 287
+#define FIXED_DIST_CODES 32
+
+#define DEFAULT_LEVEL 6
+#define DEFAULT_CHUNK_SIZE (1<<17) // input bytes per thread job
+#define BLOCK_TOKENS (1<<14) // LZ77 tokens per DEFLATE block
+#define MAX_THREADS 64
+
+// BGZF (blocked gzip, as in the SAM/BAM spec): every chunk is an independent gzip member
+// whose extra field records the member size, so readers can seek to any member.
+#define BGZF_CHUNK_SIZE 0xff00 // keeps the worst case member (stored blocks) under 64 KiB
+#define BGZF_MAX_MEMBER (1<<16)
+#define BGZF_XLEN 6
+#define BGZF_HEADER_SIZE 18 // gzip header + XLEN + BC subfield
+#define FOOTER_SIZE 8
+unsigned char bgzf_eof[28] = { // empty member that marks the end of a BGZF file
+    0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x06, 0x00, 0x42, 0x43,
+    0x02, 0x00, 0x1b, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+// Speed/ratio levels (modeled on zlib's configuration table)
+struct level_config {
+    int good_length; // walk only a quarter of the chain once a match this long is found
+    int max_lazy; // lazy: don't look for a better match above this length; greedy: max length to index
+    int nice_length; // stop searching once a match this long is found
+    int max_chain; // max number of hash chain entries to walk
+    int lazy; // 1 for lazy matching, 0 for greedy
+};
+
+struct level_config level_configs[10] = {
+    {0, 0, 0, 0, 0}, // level 0 (unused)
+    {4, 4, 8, 4, 0},
+    {4, 5, 16, 8, 0},
+    {4, 6, 32, 32, 0},
+    {4, 4, 16, 16, 1},
+    {8, 16, 32, 32, 1},
+    {8, 16, 128, 128, 1},
+    {8, 32, 128, 256, 1},
+    {32, 128, 258, 1024, 1},
+    {32, 258, 258, 4096, 1}
+};
+
+struct options {
+    int level;
+    int threads;
+    long chunk_size;
+    int independent; // BGZF-style members instead of one stream primed across chunks
+    int fixed_only; // never emit dynamic Huffman blocks
+    int verbose;
+};
+
+// Output buffer that packs bits LSB first (RFC 1951, Section 3.1.1)
+struct bit_writer {
+    unsigned char *data;
+    size_t len, cap;
+    unsigned long long bitbuf;
+    int bitcount;
+};
+
+struct token {
+    unsigned short litlen; // literal byte or match length
+    unsigned short dist; // 0 for literals
+};
+
+// LZ77 matcher state for one chunk
+struct lz_state {
+    const unsigned char *buf; // dictionary followed by the chunk
+    long total; // dictionary + chunk length
+    int *head; // most recent position for each hash
+    int *prev; // previous position with the same hash, for each position
+    struct token *tokens; // tokens of the block being built
+    int ntokens;
+    long block_start; // position in buf where the current block's input starts
+};
+
+struct huffman_code {
+    unsigned short code; // bit-reversed, so it can be written LSB first
+    unsigned char len;
+};
+
+struct chunk_job {
+    const unsigned char *in; // start of this chunk's input
+    long len;
+    long dict_len; // bytes before in to prime the matcher with (0 = independent)
+    int last; // holds the final block of the stream/member
+    struct bit_writer out;
+    unsigned long crc;
+    int done;
+};
+
+struct thread_pool {
+    pthread_mutex_t lock;
+    pthread_cond_t done_cond;
+    struct chunk_job *jobs;
+    int njobs;
+    int next; // next job to hand out
+    struct options *opts;
+};
+
+// Functions
+void init_code_tables(void);
+
+void put_byte(struct bit_writer *w, unsigned char c);
+void put_bits(struct bit_writer *w, unsigned int value, int n);
+void align_bits(struct bit_writer *w);
+
+int rle_code_lengths(const unsigned char *lens, int n, unsigned char *syms, unsigned char *extra);
+void huffman_lengths(const unsigned int *freq, int n, int limit, unsigned char *lens);
+void huffman_codes(const unsigned char *lens, int n, struct huffman_code *codes);
+
+void write_tokens(struct bit_writer *w, struct token *tokens, int ntokens, struct huffman_code *lit_codes, struct huffman_code *dist_codes);
+void write_block(struct bit_writer *w, struct token *tokens, int ntokens, const unsigned char *raw, long rawlen, int final, struct options *opts);
+void write_stored(struct bit_writer *w, const unsigned char *raw, long rawlen, int final);
+int insert_hash(struct lz_state *s, long pos);
+int longest_match(struct lz_state *s, long pos, int cand, int prev_len, struct level_config *cfg, int *dist);
+void emit_token(struct lz_state *s, struct chunk_job *job, struct options *opts, int litlen, int dist, long end);
+void deflate_chunk(struct chunk_job *job, struct options *opts);
+
+void *worker(void *arg);
+void write_out(FILE *out, const void *buf, size_t len);
+void write_header(FILE *out, struct options *opts, char *filename, time_t mtime);
+void write_footer(FILE *out, unsigned long crc, unsigned long size);
+void write_bgzf_member(FILE *out, struct chunk_job *job);
+void compress_file(char *filename, struct options *opts);
+void usage(void);
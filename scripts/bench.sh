@@ -0,0 +1,52 @@
+#!/bin/bash
+# Times ryzip against gzip at several levels on a generated corpus, and ryunzip against
+# gunzip on each result. Usage: bench.sh [corpus size in MiB] [threads]
+
+size=${1:-8}
+threads=${2:-`nproc`}
+root=`pwd`
+tmpdir=`mktemp -d`
+trap "rm -rf $tmpdir" EXIT
+
+function seconds { # command...
+  local start=`date +%s.%N`
+  "$@" > /dev/null || exit 1
+  awk "BEGIN { print `date +%s.%N` - $start }"
+}
+
+# corpus: the test files repeated (text) with some random data mixed in (incompressible)
+shopt -s nullglob
+testfiles=(tests/*.txt tests/passed/*.txt)
+shopt -u nullglob
+if [ ${#testfiles[@]} -eq 0 ]; then
+  echo "No Tests!"
+  exit 1
+fi
+while [ `stat -c %s "$tmpdir/corpus" 2>/dev/null || echo 0` -lt $((size * 1048576 * 7 / 8)) ]; do
+  cat ${testfiles[@]}
+done > "$tmpdir/corpus"
+head -c $((size * 1048576 / 8)) /dev/urandom >> "$tmpdir/corpus"
+insize=`stat -c %s "$tmpdir/corpus"`
+cd "$tmpdir"
+
+echo "Corpus: $insize bytes, $threads threads"
+printf "%-22s %10s %7s %9s %11s\n" "compressor" "bytes" "ratio" "comp (s)" "decomp (s)"
+for run in "ryzip -1" "ryzip -6" "ryzip -9" "ryzip -6 --fixed" "ryzip -6 -i" "gzip -1" "gzip -6" "gzip -9"; do
+  set -- $run
+  tool=$1
+  shift
+  if [ "$tool" = "ryzip" ]; then
+    ctime=`seconds "$root/ryzip" -p $threads "$@" corpus`
+  else
+    ctime=`seconds sh -c "gzip -k -f $* corpus"`
+  fi
+  outsize=`stat -c %s corpus.gz`
+  mv corpus corpus.orig
+  dtime=`seconds "$root/ryunzip" corpus.gz`
+  cmp -s corpus corpus.orig || { echo "$run: round trip failed"; exit 1; }
+  gtime=`seconds gzip -d -c corpus.gz`
+  mv corpus.orig corpus
+  rm corpus.gz
+  printf "%-22s %10d %7.3f %9.3f %11.3f\n" "$run" $outsize `awk "BEGIN { print $outsize / $insize }"` $ctime $dtime
+done
+echo "(decomp is ryunzip; gunzip took $gtime s on the last file)"
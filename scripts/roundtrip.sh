@@ -0,0 +1,59 @@
+#!/bin/bash
+# Compresses every test file with ryzip under several option sets, then checks the
+# result with gzip -t and decompresses it with ryunzip.
+
+shopt -s nullglob
+testfiles=(tests/*.txt tests/passed/*.txt)
+shopt -u nullglob
+
+tmpdir=`mktemp -d`
+trap "rm -rf $tmpdir" EXIT
+
+# larger inputs to exercise multiple chunks, stored blocks and empty input
+for filename in ${testfiles[@]}; do
+  for i in `seq 20`; do cat "$filename"; done
+done > "$tmpdir/multichunk.txt"
+head -c 300000 /dev/urandom > "$tmpdir/random.bin"
+cat "$tmpdir/multichunk.txt" "$tmpdir/random.bin" "$tmpdir/multichunk.txt" > "$tmpdir/mixed.bin"
+: > "$tmpdir/empty.txt"
+# names at the decoder's stored name limit (98 characters), one past it and well past it
+# (both fall back to the .gz name)
+longname=`printf 'n%.0s' $(seq 94)`
+cp ${testfiles[0]} "$tmpdir/$longname.txt"
+cp ${testfiles[0]} "$tmpdir/${longname}n.txt"
+cp ${testfiles[0]} "$tmpdir/${longname}`printf 'n%.0s' $(seq 26)`.txt"
+inputs=(${testfiles[@]} "$tmpdir"/*.txt "$tmpdir"/*.bin)
+
+optionsets=("-1" "-6" "-9" "-6 --fixed" "-6 -i" "-1 -i --fixed" "-9 -b 32 -p 4")
+
+# zip under a directory path over 100 characters, and unzip from another directory by full path
+zipdir="$tmpdir/`printf 'z%.0s' $(seq 110)`"
+unzipdir="$tmpdir/unzipped"
+
+root=`pwd`
+passed=0
+total=0
+for filename in ${inputs[@]}; do
+  name=`basename $filename`
+  for opts in "${optionsets[@]}"; do
+    ((total++))
+    mkdir "$zipdir" "$unzipdir"
+    cp "$filename" "$zipdir/$name"
+    if ! ./ryzip $opts "$zipdir/$name"; then
+      echo "$name [$opts]: ryzip failed"
+    elif ! gzip -t "$zipdir/$name.gz"; then
+      echo "$name [$opts]: gzip -t failed"
+    elif ! (cd "$unzipdir" && "$root/ryunzip" "$zipdir/$name.gz"); then
+      echo "$name [$opts]: ryunzip failed"
+    elif ! cmp -s "$unzipdir/$name" "$filename"; then
+      echo "$name [$opts]: output differs"
+    else
+      ((passed++))
+    fi
+    rm -rf "$zipdir" "$unzipdir"
+  done
+done
+echo "$passed/$total Round Trips Passed!"
+if [ $passed -ne $total ]; then
+  exit 1
+fi